@@ -0,0 +1,55 @@
+// bench/arena_bench.cpp
+// Sweeps arena entity count and reports tick cost per entity. With the grid
+// broadphase and constant ball density the ns/entity column should stay flat.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../server/arena.hpp"
+
+int main(int argc, char **argv) {
+    int ticks = (argc >= 2) ? std::atoi(argv[1]) : 600; // 10 s of game time per row
+    const int counts[] = {64, 128, 256, 512, 1024, 2048, 4096, 8192};
+
+    printf("%8s %8s %12s %10s %12s %12s\n", "balls", "paddles", "world", "tick_us", "ns/entity", "view_us");
+    for (int balls: counts) {
+        ArenaConfig cfg;
+        cfg.balls = balls;
+        cfg.paddles = std::min(64, std::max(2, balls / 16));
+        Arena arena(cfg);
+        std::vector<uint8_t> buttons(cfg.paddles, 0);
+        std::vector<uint32_t> visible;
+        std::vector<char> out;
+
+        for (int t = 0; t < 60; ++t) arena.step(buttons.data(), SERVER_TICK_MS / 1000.f); // warm up
+
+        using clk = std::chrono::steady_clock;
+        double simNs = 0, viewNs = 0;
+        size_t sink = 0;
+        for (int t = 0; t < ticks; ++t) {
+            for (int p = 0; p < cfg.paddles; ++p) buttons[p] = ((t / 30 + p) % 3 == 0) ? BTN_UP : BTN_DOWN;
+            auto t0 = clk::now();
+            arena.step(buttons.data(), SERVER_TICK_MS / 1000.f);
+            auto t1 = clk::now();
+            for (int p = 0; p < cfg.paddles; ++p) {
+                float cx, cy, hw, hh;
+                arena.paddleRect(arena.paddles[p], cx, cy, hw, hh);
+                arena.ballsNear(cx, cy, ARENA_VIEW_R, visible);
+                arena.writeState((uint8_t) p, visible, out);
+                sink += out.size();
+            }
+            auto t2 = clk::now();
+            simNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+            viewNs += std::chrono::duration<double, std::nano>(t2 - t1).count();
+        }
+
+        double perTick = simNs / ticks;
+        char world[32];
+        std::snprintf(world, sizeof(world), "%.0fx%.0f", arena.W, arena.H);
+        printf("%8d %8d %12s %10.1f %12.1f %12.1f\n", balls, cfg.paddles, world,
+               perTick / 1000.0, perTick / (balls + cfg.paddles), viewNs / ticks / 1000.0);
+        if (sink == 0) printf("(no output)\n");
+    }
+    return 0;
+}
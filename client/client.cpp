@@ -21,6 +21,7 @@ using socklen_t = int;
 #endif
 
 #include "../common/protocol.hpp"
+#include "../common/input.hpp"
 
 static bool set_tcp_nodelay(int s) {
 #ifdef _WIN32
@@ -36,9 +37,6 @@ int main(int argc, char **argv) {
     WSADATA wsa; WSAStartup(MAKEWORD(2, 2), &wsa);
 #endif
 
-    static constexpr uint8_t BTN_UP = 1 << 0;
-    static constexpr uint8_t BTN_DOWN = 1 << 1;
-
     const char *host = (argc >= 2) ? argv[1] : "127.0.0.1";
     int port = (argc >= 4 && std::string(argv[2]) == "--port") ? std::atoi(argv[3]) : 7777;
     std::string name = (argc >= 6 && std::string(argv[4]) == "--name") ? argv[5] : "Player";
@@ -87,10 +85,9 @@ int main(int argc, char **argv) {
     }
     printf("[cli] sent CHello name='%s'\n", name.c_str());
 
-    auto lastPing = std::chrono::steady_clock::now();
-    auto lastInput = std::chrono::steady_clock::now();
-    uint32_t inputSeq = 0;
-    uint8_t buttons = 0;
+    auto lastPing = std::chrono::steady_clock::now() - std::chrono::seconds(3); // first ping right away: stamps need the RTT
+    TickClock clock;
+    InputSender input;
 
     // Receive loop
     while (true) {
@@ -117,6 +114,7 @@ int main(int argc, char **argv) {
             const uint64_t nowMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::system_clock::now().time_since_epoch()).count());
             const uint64_t rtt = nowMs - p.clientSendMs;
+            clock.observeRtt((uint32_t) rtt);
             printf("[cli] S_PONG: RTT=%llums (serverRecvMs=%llu)\n",
                    static_cast<unsigned long long>(rtt),
                    static_cast<unsigned long long>(p.serverRecvMs));
@@ -124,9 +122,26 @@ int main(int argc, char **argv) {
         else if (h.type == S_STATE && h.size == sizeof(SState)) {
             SState st{};
             if (!recv_payload(s, st)) { printf("[cli] state payload error\n"); break; }
+            clock.observe(st.tick);
             printf("[cli] tick=%u ball=(%.1f,%.1f) paddles=(L %.1f | R %.1f)\n",
                    st.tick, st.ballX, st.ballY, st.paddleY[0], st.paddleY[1]);
         }
+        else if (h.type == S_ARENA_STATE && h.size >= sizeof(SArenaState)) {
+            std::vector<char> buf(h.size);
+            if (!recv_all(s, buf.data(), (int) buf.size())) { printf("[cli] arena payload error\n"); break; }
+            SArenaState as{};
+            std::memcpy(&as, buf.data(), sizeof(as));
+            if (arena_state_size(as) != h.size) {
+                printf("[cli] malformed arena state\n");
+            } else {
+                clock.observe(as.tick);
+                ArenaPaddle me{};
+                if (as.you < as.paddleCount)
+                    std::memcpy(&me, buf.data() + sizeof(as) + as.you * sizeof(ArenaPaddle), sizeof(me));
+                printf("[cli] arena tick=%u world=%.0fx%.0f paddle#%u side=%u pos=%.1f (%u paddles, %u balls in view)\n",
+                       as.tick, as.worldW, as.worldH, as.you, me.side, me.pos, as.paddleCount, as.ballCount);
+            }
+        }
         else {
             std::vector<char> junk(h.size);
             if (!recv_all(s, junk.data(), (int) junk.size())) break;
@@ -143,16 +158,12 @@ int main(int argc, char **argv) {
             printf("[cli] sent C_PING\n");
         }
 
-        // Fake input every 100ms: alternate up/down every 2 seconds
-        if (now - lastInput > std::chrono::milliseconds(100)) {
-            auto t = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
-            if ((t / 2) % 2 == 0) buttons = BTN_UP;
-            else buttons = BTN_DOWN;
-
-            CInput ci{buttons, ++inputSeq};
-            send_msg(s, C_INPUT, ci);
-            lastInput = now;
-        }
+        // Fake input: alternate up/down every 2 seconds, sent only on change (+ keepalive)
+        auto t = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
+        uint8_t buttons = ((t / 2) % 2 == 0) ? BTN_UP : BTN_DOWN;
+        bool edge = input.update(buttons, clock.estimate());
+        if (edge) printf("[cli] input edge seq=%u buttons=%u\n", input.msg.seq, buttons);
+        input.pump(s, edge);
     }
 
     closesocket(s);
@@ -7,6 +7,7 @@
 #include <mutex>
 #include <chrono>
 #include <vector>
+#include <algorithm>
 
 #ifdef _WIN32
   #include <winsock2.h>
@@ -24,6 +25,7 @@
 
 #include <SDL.h>
 #include "../common/protocol.hpp"
+#include "../common/input.hpp"
 
 static bool set_tcp_nodelay(int s){
 #ifdef _WIN32
@@ -74,6 +76,8 @@ int main(int argc,char** argv){
   // shared state from network
   std::mutex mtx;
   SState latest{};             // last authoritative state
+  std::vector<char> arena;     // last S_ARENA_STATE payload (empty in classic mode)
+  TickClock clock;             // server tick estimate (guarded by mtx)
   std::atomic<bool> running{true};
 
   // ---- RX thread ----
@@ -83,10 +87,16 @@ int main(int argc,char** argv){
       if (!recv_header(s, hh)){ printf("[cli] server closed\n"); running.store(false); break; }
       if (hh.type==S_STATE && hh.size==sizeof(SState)){
         SState st{}; if (!recv_payload(s,st)){ running.store(false); break; }
-        std::lock_guard<std::mutex> lk(mtx); latest = st;
+        std::lock_guard<std::mutex> lk(mtx); latest = st; clock.observe(st.tick);
+      }else if (hh.type==S_ARENA_STATE && hh.size>=sizeof(SArenaState)){
+        std::vector<char> buf(hh.size);
+        if (!recv_all(s, buf.data(), (int)buf.size())){ running.store(false); break; }
+        SArenaState as{}; std::memcpy(&as, buf.data(), sizeof(as));
+        if (arena_state_size(as) != hh.size) continue; // malformed: counts don't match the payload
+        std::lock_guard<std::mutex> lk(mtx); arena.swap(buf); clock.observe(as.tick);
       }else if (hh.type==S_PONG && hh.size==sizeof(SPong)){
         SPong p{}; if (!recv_payload(s,p)){ running.store(false); break; }
-        (void)p; // (optional) compute/print RTT
+        std::lock_guard<std::mutex> lk(mtx); clock.observeRtt((uint32_t)(now_ms() - p.clientSendMs));
       }else{
         std::vector<char> junk(hh.size);
         if (!recv_all(s, junk.data(), (int)junk.size())){ running.store(false); break; }
@@ -95,9 +105,8 @@ int main(int argc,char** argv){
   });
 
   // ---- input + render loop ----
-  uint8_t buttons=0; uint32_t inputSeq=0;
-  auto lastPing = std::chrono::steady_clock::now();
-  auto lastInput= std::chrono::steady_clock::now();
+  uint8_t buttons=0; InputSender input;
+  auto lastPing = std::chrono::steady_clock::now() - std::chrono::seconds(3); // first ping right away: stamps need the RTT
 
   while (running.load()){
     // input
@@ -106,8 +115,10 @@ int main(int argc,char** argv){
       if (e.type==SDL_QUIT) running.store(false);
       if (e.type==SDL_KEYDOWN || e.type==SDL_KEYUP){
         bool down = (e.type==SDL_KEYDOWN);
-        if (e.key.keysym.sym==SDLK_UP)    { if (down) buttons |= BTN_UP;   else buttons &= ~BTN_UP; }
-        if (e.key.keysym.sym==SDLK_DOWN)  { if (down) buttons |= BTN_DOWN; else buttons &= ~BTN_DOWN; }
+        // left/right drive paddles on the top/bottom edges of the arena
+        SDL_Keycode k = e.key.keysym.sym;
+        if (k==SDLK_UP   || k==SDLK_LEFT)  { if (down) buttons |= BTN_UP;   else buttons &= ~BTN_UP; }
+        if (k==SDLK_DOWN || k==SDLK_RIGHT) { if (down) buttons |= BTN_DOWN; else buttons &= ~BTN_DOWN; }
       }
     }
 
@@ -116,17 +127,43 @@ int main(int argc,char** argv){
     if (now - lastPing > std::chrono::seconds(3)){
       CPing ping{ now_ms() }; send_msg(s, C_PING, ping); lastPing = now;
     }
-    // send inputs ~60Hz
-    if (now - lastInput > std::chrono::milliseconds(16)){
-      CInput in{ buttons, ++inputSeq }; send_msg(s, C_INPUT, in); lastInput = now;
-    }
+    // send inputs on change, plus a slow keepalive
+    uint32_t tickEst; { std::lock_guard<std::mutex> lk(mtx); tickEst = clock.estimate(); }
+    input.pump(s, input.update(buttons, tickEst));
 
     // snapshot for render
-    SState st{}; { std::lock_guard<std::mutex> lk(mtx); st = latest; }
+    SState st{}; std::vector<char> ar;
+    { std::lock_guard<std::mutex> lk(mtx); st = latest; ar = arena; }
 
     // render
     SDL_SetRenderDrawColor(ren, 18,18,20,255); SDL_RenderClear(ren);
 
+    if (!ar.empty()){
+      // arena: scale the world to fit, own paddle highlighted
+      SArenaState as{}; std::memcpy(&as, ar.data(), sizeof(as));
+      const char* p = ar.data() + sizeof(as);
+      float k = std::min(WIN_W / as.worldW, WIN_H / as.worldH);
+      for (int i=0; i<as.paddleCount; ++i, p+=sizeof(ArenaPaddle)){
+        ArenaPaddle ap{}; std::memcpy(&ap, p, sizeof(ap));
+        bool vert = (ap.side<2);
+        float cx = ap.side==0 ? 20.f : ap.side==1 ? as.worldW-20.f : ap.pos;
+        float cy = ap.side==2 ? 20.f : ap.side==3 ? as.worldH-20.f : ap.pos;
+        float w = vert ? 10.f : 80.f, hgt = vert ? 80.f : 10.f;
+        if (i==as.you) SDL_SetRenderDrawColor(ren, 90,200,255,255); else SDL_SetRenderDrawColor(ren, 240,240,240,255);
+        SDL_Rect r{ (int)((cx-w/2)*k), (int)((cy-hgt/2)*k), std::max(1,(int)(w*k)), std::max(1,(int)(hgt*k)) };
+        SDL_RenderFillRect(ren, &r);
+      }
+      SDL_SetRenderDrawColor(ren, 240,240,240,255);
+      int bs = std::max(2, (int)(12*k));
+      for (int i=0; i<as.ballCount; ++i, p+=sizeof(ArenaBall)){
+        ArenaBall ab{}; std::memcpy(&ab, p, sizeof(ab));
+        SDL_Rect b{ (int)(ab.x*k) - bs/2, (int)(ab.y*k) - bs/2, bs, bs };
+        SDL_RenderFillRect(ren, &b);
+      }
+      SDL_RenderPresent(ren);
+      continue;
+    }
+
     // ball (12x12)
     SDL_SetRenderDrawColor(ren, 240,240,240,255);
     SDL_Rect ball{ (int)(st.ballX - 6), (int)(st.ballY - 6), 12, 12 };
@@ -0,0 +1,109 @@
+#pragma once
+// Gateway <-> backend control channel (Unix domain socket, same machine).
+// Framing is the usual MsgHeader + payload; G_ASSIGN also carries the
+// client sockets as SCM_RIGHTS, so the gateway never copies game traffic.
+#include <cstdint>
+#include <cstring>
+
+#include "protocol.hpp"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+
+enum : uint8_t {
+    G_ASSIGN = 40, // gateway -> backend: new match, client fds attached
+    G_LOAD = 41    // backend -> gateway: periodic health/load report
+};
+
+static constexpr int MATCH_PLAYERS = 2;
+static constexpr int LOAD_REPORT_MS = 500;
+
+#pragma pack(push,1)
+struct GAssign {
+    uint32_t matchId;
+    uint8_t  players;   // number of fds attached, <= MATCH_PLAYERS
+};
+
+struct GLoad {
+    uint16_t matches;
+    uint16_t clients;
+    uint32_t tickUs;    // mean simulation cost per tick over the last report period
+    uint8_t  draining;  // 1 = finishing current matches, take no new ones
+};
+#pragma pack(pop)
+
+inline bool unix_addr(const char *path, sockaddr_un &a) {
+    std::memset(&a, 0, sizeof(a));
+    a.sun_family = AF_UNIX;
+    if (std::strlen(path) >= sizeof(a.sun_path)) return false;
+    std::strcpy(a.sun_path, path);
+    return true;
+}
+
+// Control buffer for up to MATCH_PLAYERS fds, aligned for CMSG_FIRSTHDR.
+union FdCtrl {
+    cmsghdr h;
+    char buf[CMSG_SPACE(sizeof(int) * MATCH_PLAYERS)];
+};
+
+// send_msg_fds outcome. FD_SEND_PARTIAL means the fds reached the peer but the
+// rest of the message didn't: the channel is broken and the fds must not be
+// sent anywhere else.
+enum FdSend { FD_SEND_FAILED, FD_SEND_PARTIAL, FD_SEND_OK };
+
+// Send one message with `n` (1..MATCH_PLAYERS) file descriptors attached to it.
+template<class T>
+inline FdSend send_msg_fds(int s, uint8_t type, const T &payload, const int *fds, int n) {
+    if (n <= 0 || n > MATCH_PLAYERS) return FD_SEND_FAILED;
+    char data[sizeof(MsgHeader) + sizeof(T)];
+    MsgHeader h{type, static_cast<uint16_t>(sizeof(T))};
+    std::memcpy(data, &h, sizeof(h));
+    std::memcpy(data + sizeof(h), &payload, sizeof(T));
+
+    iovec iov{data, sizeof(data)};
+    FdCtrl ctrl;
+    std::memset(&ctrl, 0, sizeof(ctrl));
+    msghdr m{};
+    m.msg_iov = &iov;
+    m.msg_iovlen = 1;
+    m.msg_control = ctrl.buf;
+    m.msg_controllen = CMSG_SPACE(sizeof(int) * n);
+    cmsghdr *c = CMSG_FIRSTHDR(&m);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type = SCM_RIGHTS;
+    c->cmsg_len = CMSG_LEN(sizeof(int) * n);
+    std::memcpy(CMSG_DATA(c), fds, sizeof(int) * n);
+
+    ssize_t k = sendmsg(s, &m, 0);
+    if (k <= 0) return FD_SEND_FAILED;
+    // fds ride on the first byte, so from here on they are delivered
+    return send_all(s, data + k, (int) (sizeof(data) - k)) ? FD_SEND_OK : FD_SEND_PARTIAL;
+}
+
+// Read one message header; any fds that arrive with it land in fds[0..*n).
+inline bool recv_header_fds(int s, MsgHeader &h, int *fds, int &n) {
+    iovec iov{&h, sizeof(h)};
+    FdCtrl ctrl;
+    msghdr m{};
+    m.msg_iov = &iov;
+    m.msg_iovlen = 1;
+    m.msg_control = ctrl.buf;
+    m.msg_controllen = sizeof(ctrl.buf);
+
+    n = 0;
+    ssize_t k = recvmsg(s, &m, 0);
+    if (k <= 0) return false;
+    for (cmsghdr *c = CMSG_FIRSTHDR(&m); c; c = CMSG_NXTHDR(&m, c)) {
+        if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+        int got = (int) ((c->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        for (int i = 0; i < got; ++i) {
+            int fd;
+            std::memcpy(&fd, CMSG_DATA(c) + i * sizeof(int), sizeof(int));
+            if (n < MATCH_PLAYERS) fds[n++] = fd;
+            else close(fd);
+        }
+    }
+    return recv_all(s, (char *) &h + k, (int) (sizeof(h) - k));
+}
+#endif
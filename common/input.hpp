@@ -0,0 +1,111 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+
+#include "protocol.hpp"
+
+// ----- client side: server tick estimate -----
+// Tracks the last S_STATE tick and extrapolates at the server's 16 ms step.
+// The state was already a one-way trip old when it arrived, and the input
+// needs another trip to get back, so stamps lead by a full RTT plus a small
+// jitter buffer: an edge is stamped with the tick it should reach the server on.
+struct TickClock {
+    static constexpr int JITTER_MS = SERVER_TICK_MS; // one tick of slack
+
+    uint32_t lastTick = 0;
+    uint32_t rttMs = 0;
+    std::chrono::steady_clock::time_point lastAt = std::chrono::steady_clock::now();
+
+    void observe(uint32_t tick) {
+        lastTick = tick;
+        lastAt = std::chrono::steady_clock::now();
+    }
+
+    // Feed RTT samples from S_PONG; smoothed so one slow ping doesn't jump the stamps.
+    void observeRtt(uint32_t ms) {
+        rttMs = rttMs ? (rttMs * 7 + ms) / 8 : ms;
+    }
+
+    uint32_t estimate() const {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - lastAt).count();
+        return lastTick + (uint32_t) ((elapsed + rttMs + JITTER_MS) / SERVER_TICK_MS);
+    }
+};
+
+// ----- client side: edge history -----
+// Sends only when the buttons change (plus a slow keepalive). Every packet
+// carries the last INPUT_HISTORY edges, so one dropped packet loses nothing.
+struct InputSender {
+    CInput msg{};
+    uint8_t buttons = 0;
+    std::chrono::steady_clock::time_point lastSend{};
+
+    // Record a new button state; returns true if it was an edge.
+    bool update(uint8_t b, uint32_t tick) {
+        if (b == buttons && msg.seq != 0) return false;
+        buttons = b;
+        for (int k = INPUT_HISTORY - 1; k > 0; --k) msg.edges[k] = msg.edges[k - 1];
+        msg.edges[0] = InputEdge{tick, b};
+        if (msg.count < INPUT_HISTORY) msg.count++;
+        msg.seq++;
+        return true;
+    }
+
+    // Send on a fresh edge, or re-send the current history as a keepalive.
+    bool pump(int s, bool edge) {
+        auto now = std::chrono::steady_clock::now();
+        if (!edge && now - lastSend < std::chrono::milliseconds(INPUT_KEEPALIVE_MS)) return true;
+        if (msg.seq == 0) return true;
+        lastSend = now;
+        return send_msg(s, C_INPUT, msg);
+    }
+};
+
+// ----- server side: per-player edge queue -----
+// Dedups by seq and releases each edge on the tick it was stamped with.
+struct InputQueue {
+    static constexpr uint32_t MAX_LEAD_TICKS = 8; // clamp clients that run ahead
+    static constexpr size_t MAX_PENDING = 4 * INPUT_HISTORY; // flood guard, oldest dropped first
+
+    uint32_t lastSeq = 0;
+    uint8_t buttons = 0;
+    std::deque<InputEdge> pending; // ascending tick order
+
+    // Returns how many new edges were queued.
+    int receive(const CInput &ci, uint32_t serverTick) {
+        if (ci.seq <= lastSeq) return 0; // duplicate or keepalive
+        uint32_t fresh = ci.seq - lastSeq;
+        int n = ci.count < INPUT_HISTORY ? ci.count : INPUT_HISTORY;
+        if (fresh < (uint32_t) n) n = (int) fresh;
+        lastSeq = ci.seq;
+        if (n <= 0) return 0;
+        // Late edges (e.g. recovered from the history) shift as a group so
+        // a press keeps its length instead of collapsing onto one tick.
+        uint32_t oldest = ci.edges[n - 1].tick;
+        uint32_t shift = oldest <= serverTick ? serverTick + 1 - oldest : 0;
+        // edges[] is newest-first; queue oldest-first
+        for (int k = n - 1; k >= 0; --k) {
+            InputEdge e = ci.edges[k];
+            e.tick += shift;
+            if (e.tick > serverTick + MAX_LEAD_TICKS) e.tick = serverTick + MAX_LEAD_TICKS;
+            if (!pending.empty() && e.tick < pending.back().tick) e.tick = pending.back().tick;
+            pending.push_back(e);
+        }
+        while (pending.size() > MAX_PENDING) pending.pop_front();
+        return n;
+    }
+
+    // Apply every edge due on `tick`. Stops after a press so that a press and
+    // its release landing on the same tick still move the paddle for a tick.
+    uint8_t advance(uint32_t tick) {
+        while (!pending.empty() && pending.front().tick <= tick) {
+            uint8_t prev = buttons;
+            buttons = pending.front().buttons;
+            pending.pop_front();
+            if (buttons & ~prev) break;
+        }
+        return buttons;
+    }
+};
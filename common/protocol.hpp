@@ -1,5 +1,7 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 
 #pragma pack(push,1)
@@ -15,13 +17,24 @@ enum : uint8_t {
     C_PING = 4,
     S_PONG = 5,
     C_INPUT = 20, // client -> server paddle input
-    S_STATE = 21 // server -> client authoritative state
+    S_STATE = 21, // server -> client authoritative state
+    S_ARENA_STATE = 22 // server -> client arena state (variable size)
 };
 
+static constexpr int INPUT_HISTORY = 4;        // edges carried per CInput
+static constexpr int INPUT_KEEPALIVE_MS = 500;  // re-send period when idle
+static constexpr int SERVER_TICK_MS = 16;
+
 #pragma pack(push,1)
-struct CInput {
+struct InputEdge {
+    uint32_t tick;      // server tick the change happened on (client estimate)
     uint8_t  buttons;   // bit0=UP, bit1=DOWN
-    uint32_t seq;       // client-side counter for debugging
+};
+
+struct CInput {
+    uint32_t  seq;      // seq of edges[0]; edges[k] has seq - k
+    uint8_t   count;    // valid entries in edges
+    InputEdge edges[INPUT_HISTORY]; // newest first
 };
 
 struct SState {
@@ -30,8 +43,34 @@ struct SState {
     float    ballVX, ballVY;
     float    paddleY[2];  // [0]=left, [1]=right
 };
+
+// S_ARENA_STATE payload: this header, then paddleCount ArenaPaddle,
+// then ballCount ArenaBall (only the balls near the receiver's paddle).
+struct SArenaState {
+    uint32_t tick;
+    float    worldW, worldH;
+    uint8_t  you;         // index of the receiver's paddle
+    uint8_t  paddleCount;
+    uint16_t ballCount;
+};
+
+struct ArenaPaddle {
+    uint8_t side;         // 0=left, 1=right, 2=top, 3=bottom
+    float   pos;          // centre along its edge
+};
+
+struct ArenaBall {
+    uint16_t id;
+    float    x, y;
+    float    vx, vy;
+};
 #pragma pack(pop)
 
+// Exact payload size an S_ARENA_STATE with this header must have.
+inline size_t arena_state_size(const SArenaState &a) {
+    return sizeof(SArenaState) + a.paddleCount * sizeof(ArenaPaddle) + a.ballCount * sizeof(ArenaBall);
+}
+
 #pragma pack(push,1)
 struct CPing {
     uint64_t clientSendMs;
@@ -66,15 +105,18 @@ static constexpr uint8_t BTN_DOWN = 1 << 1;
 #include <winsock2.h>
 #pragma comment(lib, "Ws2_32.lib")
 #else
+#include <cerrno>
+#include <fcntl.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #endif
 
-inline bool send_all(int s, const void *d, int len) {
+// flags go straight to send(); MSG_DONTWAIT makes a full socket buffer a failure.
+inline bool send_all(int s, const void *d, int len, int flags = 0) {
     const char *p = (const char *) d;
     int left = len;
     while (left > 0) {
-        int n = send(s, p, left, 0);
+        int n = send(s, p, left, flags);
         if (n <= 0) return false;
         p += n;
         left -= n;
@@ -94,15 +136,71 @@ inline bool recv_all(int s, void *d, int len) {
     return true;
 }
 
-inline bool send_header(int s, const MsgHeader &h) { return send_all(s, &h, sizeof(h)); }
+inline bool send_header(int s, const MsgHeader &h, int flags = 0) { return send_all(s, &h, sizeof(h), flags); }
 
 template<class T>
-inline bool send_msg(int s, uint8_t type, const T &payload) {
+inline bool send_msg(int s, uint8_t type, const T &payload, int flags = 0) {
     MsgHeader h{type, static_cast<uint16_t>(sizeof(T))};
-    return send_header(s, h) && send_all(s, &payload, sizeof(T));
+    return send_header(s, h, flags) && send_all(s, &payload, sizeof(T), flags);
+}
+
+inline bool send_bytes(int s, uint8_t type, const void *d, uint16_t len) {
+    MsgHeader h{type, len};
+    return send_header(s, h) && send_all(s, d, len);
 }
 
 inline bool recv_header(int s, MsgHeader &h) { return recv_all(s, &h, sizeof(h)); }
 
 template<class T>
 inline bool recv_payload(int s, T &out) { return recv_all(s, &out, sizeof(T)); }
+
+// ----- non-blocking framed reads -----
+inline bool set_nonblocking(int s) {
+#ifdef _WIN32
+    u_long on = 1;
+    return ioctlsocket(s, FIONBIO, &on) == 0;
+#else
+    int fl = fcntl(s, F_GETFL, 0);
+    return fl >= 0 && fcntl(s, F_SETFL, fl | O_NONBLOCK) == 0;
+#endif
+}
+
+inline bool would_block() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+// Per-connection receive buffer for a non-blocking socket. fill() takes what
+// has arrived, next() hands out only complete frames, so a peer that stops
+// mid-message stalls nobody but itself.
+struct FrameReader {
+    std::vector<char> buf;
+    size_t head = 0; // start of the first unconsumed frame
+
+    // One recv of whatever is available. false = peer closed or error.
+    bool fill(int s) {
+        if (head > 0) {
+            buf.erase(buf.begin(), buf.begin() + (long) head);
+            head = 0;
+        }
+        char tmp[4096];
+        int n = recv(s, tmp, sizeof(tmp), 0);
+        if (n == 0) return false;
+        if (n < 0) return would_block();
+        buf.insert(buf.end(), tmp, tmp + n);
+        return true;
+    }
+
+    // Next complete frame; payload stays valid until the next fill().
+    bool next(MsgHeader &h, const char *&payload) {
+        if (buf.size() - head < sizeof(h)) return false;
+        std::memcpy(&h, buf.data() + head, sizeof(h));
+        if (buf.size() - head < sizeof(h) + h.size) return false;
+        payload = buf.data() + head + sizeof(h);
+        head += sizeof(h) + h.size;
+        return true;
+    }
+};
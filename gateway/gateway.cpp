@@ -0,0 +1,346 @@
+// gateway/gateway.cpp
+// Front door for several local pong_server backends. Accepts clients, does the
+// S_HELLO/C_HELLO handshake, pairs them into matches and hands both sockets of
+// a match to the least-loaded backend over its Unix socket (SCM_RIGHTS). After
+// the hand-off the backend owns the TCP connection; no game bytes pass here.
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+int main() {
+    printf("[gw] pong_gateway needs Unix domain sockets\n");
+    return 1;
+}
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define closesocket close
+
+#include "../common/protocol.hpp"
+#include "../common/gateway.hpp"
+
+using clk = std::chrono::steady_clock;
+
+static bool set_tcp_nodelay(int s) {
+    int yes = 1;
+    return setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes)) == 0;
+}
+
+static uint32_t now_steady_ms() {
+    return (uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+        clk::now().time_since_epoch()).count();
+}
+
+struct Backend {
+    std::string path;
+    int fd = -1;
+    GLoad load{};
+    int pending = 0;            // matches sent since the last report
+    clk::time_point lastReport{};
+    clk::time_point lastTry{};
+    size_t pollAt = 0;          // index in pfds, 0 = not polled this round (pfds[0] is the listener)
+
+    bool healthy(clk::time_point now) const {
+        return fd >= 0 && !load.draining && now - lastReport < std::chrono::seconds(2);
+    }
+};
+
+static void backend_connect(Backend &b) {
+    b.lastTry = clk::now();
+    sockaddr_un ua{};
+    if (!unix_addr(b.path.c_str(), ua)) return;
+    int s = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s < 0) return;
+    if (connect(s, (sockaddr *) &ua, sizeof(ua)) < 0) {
+        closesocket(s);
+        return;
+    }
+    b.fd = s;
+    b.load = GLoad{};
+    b.pending = 0;
+    b.lastReport = clk::now(); // grace period until the first report
+    printf("[gw] backend %s up\n", b.path.c_str());
+}
+
+static void backend_down(Backend &b) {
+    printf("[gw] backend %s down\n", b.path.c_str());
+    closesocket(b.fd);
+    b.fd = -1;
+}
+
+// Least matches (counting ones not yet reported), then cheapest tick.
+static Backend *pick_backend(std::vector<Backend> &backends) {
+    auto now = clk::now();
+    Backend *best = nullptr;
+    for (Backend &b: backends) {
+        if (!b.healthy(now)) continue;
+        if (!best) {
+            best = &b;
+            continue;
+        }
+        int lb = b.load.matches + b.pending, lbest = best->load.matches + best->pending;
+        if (lb < lbest || (lb == lbest && b.load.tickUs < best->load.tickUs)) best = &b;
+    }
+    return best;
+}
+
+static bool set_blocking(int s, bool on) {
+    int fl = fcntl(s, F_GETFL, 0);
+    if (fl < 0) return false;
+    return fcntl(s, F_SETFL, on ? (fl & ~O_NONBLOCK) : (fl | O_NONBLOCK)) == 0;
+}
+
+// A client between accept and the end of its C_HELLO. The handshake runs
+// non-blocking inside the main poll loop, so a slow or silent client only
+// costs its own deadline, never the other connections or backend reports.
+struct Handshake {
+    static constexpr int TIMEOUT_MS = 2000;
+
+    int fd = -1;
+    clk::time_point deadline{};
+    char buf[sizeof(MsgHeader) + sizeof(CHello)];
+    size_t got = 0;
+    size_t pollAt = 0;
+};
+
+// Clients in handshake or waiting in the lobby. Past this, new connections are
+// refused so a connection flood can't run the gateway out of fds.
+static constexpr size_t MAX_WAITING = 512;
+
+static bool readable(const pollfd &p) { return (p.revents & (POLLIN | POLLHUP | POLLERR)) != 0; }
+
+// Accept one client, greet it and start its handshake (or refuse it when
+// `full`). Returns false if nothing was accepted.
+static bool accept_client(int ls, std::vector<Handshake> &shaking, bool full) {
+    sockaddr_in cli{};
+    socklen_t cl = sizeof(cli);
+    int s = accept(ls, (sockaddr *) &cli, &cl);
+    if (s < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) perror("[gw] accept");
+        return false;
+    }
+    set_tcp_nodelay(s);
+
+    char ip[64];
+    inet_ntop(AF_INET, &cli.sin_addr, ip, sizeof(ip));
+    if (full) {
+        printf("[gw] full, refusing %s:%d\n", ip, ntohs(cli.sin_port));
+        closesocket(s);
+        return true;
+    }
+    printf("[gw] client connected: %s:%d\n", ip, ntohs(cli.sin_port));
+
+    // fresh socket, empty send buffer: the greeting goes out without blocking
+    if (!set_blocking(s, false) || !send_msg(s, S_HELLO, SHello{now_steady_ms()}, MSG_DONTWAIT)) {
+        closesocket(s);
+        return true;
+    }
+    Handshake hs;
+    hs.fd = s;
+    hs.deadline = clk::now() + std::chrono::milliseconds(Handshake::TIMEOUT_MS);
+    shaking.push_back(hs);
+    return true;
+}
+
+// Read what is available of C_HELLO. Returns -1 on failure, 0 while
+// incomplete, 1 once it is done (the socket is back in blocking mode).
+static int continue_handshake(Handshake &hs) {
+    // never read past C_HELLO: anything after it belongs to the backend
+    ssize_t n = recv(hs.fd, hs.buf + hs.got, sizeof(hs.buf) - hs.got, 0);
+    if (n == 0) return -1;
+    if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    hs.got += (size_t) n;
+
+    MsgHeader h{};
+    if (hs.got >= sizeof(h)) {
+        std::memcpy(&h, hs.buf, sizeof(h));
+        if (h.type != C_HELLO || h.size != sizeof(CHello)) return -1;
+    }
+    if (hs.got < sizeof(hs.buf)) return 0;
+
+    CHello ch{};
+    std::memcpy(&ch, hs.buf + sizeof(h), sizeof(ch));
+    printf("[gw]   name='%.*s'\n", (int) sizeof(ch.name), ch.name);
+    return set_blocking(hs.fd, true) ? 1 : -1;
+}
+
+// Peer still there? Anything it already sent stays queued for the backend.
+static bool client_alive(int s) {
+    char c;
+    ssize_t n = recv(s, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+
+int main(int argc, char **argv) {
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int port = 7777;
+    std::vector<Backend> backends;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string k = argv[i];
+        if (k == "--port") port = std::atoi(argv[i + 1]);
+        else if (k == "--backend") backends.push_back(Backend{argv[i + 1]});
+    }
+    if (backends.empty()) {
+        printf("usage: pong_gateway [--port N] --backend PATH [--backend PATH ...]\n");
+        return 1;
+    }
+    for (Backend &b: backends) backend_connect(b);
+
+    int ls = socket(AF_INET, SOCK_STREAM, 0);
+    if (ls < 0) {
+        perror("[gw] socket");
+        return 1;
+    }
+    int opt = 1;
+    setsockopt(ls, SOL_SOCKET, SO_REUSEADDR, (char *) &opt, sizeof(opt));
+
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_ANY);
+    a.sin_port = htons(port);
+    if (bind(ls, (sockaddr *) &a, sizeof(a)) < 0) {
+        perror("[gw] bind");
+        return 1;
+    }
+    if (listen(ls, 64) < 0) {
+        perror("[gw] listen");
+        return 1;
+    }
+    set_blocking(ls, false);
+    printf("[gw] listening on 0.0.0.0:%d, %zu backends\n", port, backends.size());
+
+    std::vector<Handshake> shaking; // accepted, C_HELLO not complete yet
+    std::vector<int> lobby;         // handshaken clients waiting for a match, in arrival order
+    uint32_t nextMatch = 1;
+    auto nextStatus = clk::now() + std::chrono::seconds(5);
+    std::vector<pollfd> pfds;
+
+    for (;;) {
+        // poll, not select: client fds can pass FD_SETSIZE
+        pfds.clear();
+        pfds.push_back(pollfd{ls, POLLIN, 0});
+        for (Backend &b: backends) {
+            b.pollAt = 0;
+            if (b.fd < 0) continue;
+            b.pollAt = pfds.size();
+            pfds.push_back(pollfd{b.fd, POLLIN, 0});
+        }
+        for (Handshake &hs: shaking) {
+            hs.pollAt = pfds.size();
+            pfds.push_back(pollfd{hs.fd, POLLIN, 0});
+        }
+
+        int ready = poll(pfds.data(), (unsigned long) pfds.size(), 100);
+        auto now = clk::now();
+
+        // ---- handshakes: advance readable ones, expire the silent ones ----
+        for (size_t i = 0; i < shaking.size();) {
+            Handshake &hs = shaking[i];
+            int r = 0;
+            if (ready > 0 && readable(pfds[hs.pollAt])) r = continue_handshake(hs);
+            if (r == 0 && now >= hs.deadline) r = -1;
+            if (r == 0) {
+                ++i;
+                continue;
+            }
+            if (r > 0) {
+                lobby.push_back(hs.fd);
+            } else {
+                printf("[gw]   handshake failed\n");
+                closesocket(hs.fd);
+            }
+            shaking.erase(shaking.begin() + (long) i);
+        }
+
+        // after the handshake pass, so every entry in `shaking` there was polled
+        if (ready > 0 && readable(pfds[0])) {
+            while (accept_client(ls, shaking, shaking.size() + lobby.size() >= MAX_WAITING)) {}
+        }
+
+        // ---- backend reports ----
+        for (Backend &b: backends) {
+            if (b.fd < 0 || b.pollAt == 0 || ready <= 0 || !readable(pfds[b.pollAt])) continue;
+            MsgHeader h{};
+            if (!recv_header(b.fd, h)) {
+                backend_down(b);
+                continue;
+            }
+            if (h.type == G_LOAD && h.size == sizeof(GLoad)) {
+                GLoad ld{};
+                if (!recv_payload(b.fd, ld)) {
+                    backend_down(b);
+                    continue;
+                }
+                if (ld.draining && !b.load.draining) printf("[gw] backend %s draining\n", b.path.c_str());
+                b.load = ld;
+                b.pending = 0;
+                b.lastReport = now;
+            } else {
+                std::vector<char> junk(h.size);
+                if (!recv_all(b.fd, junk.data(), (int) junk.size())) backend_down(b);
+            }
+        }
+
+        // ---- health: reconnect, or drop backends that went quiet ----
+        for (Backend &b: backends) {
+            if (b.fd < 0 && now - b.lastTry > std::chrono::seconds(1)) backend_connect(b);
+            else if (b.fd >= 0 && now - b.lastReport > std::chrono::seconds(5)) backend_down(b);
+        }
+
+        // ---- pair clients and hand each match to one backend ----
+        for (size_t i = 0; i < lobby.size();) {
+            if (client_alive(lobby[i])) {
+                ++i;
+                continue;
+            }
+            printf("[gw] waiting client left\n");
+            closesocket(lobby[i]);
+            lobby.erase(lobby.begin() + (long) i);
+        }
+        while ((int) lobby.size() >= MATCH_PLAYERS) {
+            Backend *b = pick_backend(backends);
+            if (!b) break; // keep them waiting until a backend is healthy
+            GAssign ga{nextMatch, (uint8_t) MATCH_PLAYERS};
+            FdSend r = send_msg_fds(b->fd, G_ASSIGN, ga, lobby.data(), MATCH_PLAYERS);
+            if (r == FD_SEND_FAILED) {
+                backend_down(*b);
+                continue; // nothing left here, try the next backend
+            }
+            if (r == FD_SEND_PARTIAL) {
+                // the backend already holds these sockets; never hand them out twice
+                printf("[gw] match %u lost: %s broke mid-assign\n", nextMatch, b->path.c_str());
+                backend_down(*b);
+            } else {
+                printf("[gw] match %u -> %s\n", nextMatch, b->path.c_str());
+                b->pending++;
+            }
+            nextMatch++;
+            for (int k = 0; k < MATCH_PLAYERS; ++k) closesocket(lobby[k]);
+            lobby.erase(lobby.begin(), lobby.begin() + MATCH_PLAYERS);
+        }
+
+        if (now >= nextStatus) {
+            nextStatus = now + std::chrono::seconds(5);
+            for (const Backend &b: backends) {
+                printf("[gw] %-24s %-8s matches=%u clients=%u tick=%uus\n", b.path.c_str(),
+                       b.fd < 0 ? "down" : b.load.draining ? "draining" : b.healthy(now) ? "ok" : "stale",
+                       b.load.matches, b.load.clients, b.load.tickUs);
+            }
+            printf("[gw] lobby=%zu\n", lobby.size());
+        }
+    }
+}
+#endif
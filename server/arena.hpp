@@ -0,0 +1,264 @@
+// server/arena.hpp
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "../common/protocol.hpp"
+
+// ----- arena constants -----
+static constexpr float ARENA_PADDLE_H = 80.f, ARENA_PADDLE_W = 10.f;
+static constexpr float ARENA_PADDLE_INSET = 20.f;   // paddle centre distance from its edge
+static constexpr float ARENA_BALL_R = 6.f;
+static constexpr float ARENA_PADDLE_SPEED = 260.f;  // px/s
+static constexpr float ARENA_BALL_SPEED = 260.f;
+static constexpr float ARENA_SEGMENT = 240.f;       // edge length owned by one paddle
+static constexpr float ARENA_AREA_PER_BALL = 90.f * 90.f; // keeps density flat as balls grow
+static constexpr float ARENA_CELL = 32.f;           // >= 2*BALL_R + per-tick travel
+static constexpr float ARENA_VIEW_R = 500.f;        // interest radius around a client's paddle
+
+// Sides a paddle can sit on; left/right move along y, top/bottom along x.
+enum : uint8_t { SIDE_LEFT = 0, SIDE_RIGHT = 1, SIDE_TOP = 2, SIDE_BOTTOM = 3 };
+
+struct ArenaConfig {
+    int paddles = 2;
+    int balls = 1;
+    uint32_t seed = 1;
+};
+
+// ----- uniform grid broadphase -----
+// Rebuilt every tick with a counting sort, so build is O(n + cells) and a
+// query only touches the items in the cells it overlaps.
+struct UniformGrid {
+    float cell = ARENA_CELL;
+    int cols = 1, rows = 1;
+    std::vector<uint32_t> cellStart; // cols*rows + 1 prefix offsets into items
+    std::vector<uint32_t> items;
+    std::vector<uint32_t> itemCell;  // scratch: cell of each item
+    std::vector<uint32_t> cursor;    // scratch: fill position per cell
+
+    void resize(float w, float h, float cellSize) {
+        cell = cellSize;
+        cols = std::max(1, (int) std::ceil(w / cell));
+        rows = std::max(1, (int) std::ceil(h / cell));
+        cellStart.assign((size_t) cols * rows + 1, 0);
+        cursor.assign((size_t) cols * rows, 0);
+    }
+
+    int col(float x) const { return std::min(cols - 1, std::max(0, (int) (x / cell))); }
+    int row(float y) const { return std::min(rows - 1, std::max(0, (int) (y / cell))); }
+
+    template<class PosFn>
+    void build(size_t n, PosFn pos) {
+        std::fill(cellStart.begin(), cellStart.end(), 0);
+        itemCell.resize(n);
+        items.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            float x, y;
+            pos(i, x, y);
+            uint32_t c = (uint32_t) (row(y) * cols + col(x));
+            itemCell[i] = c;
+            cellStart[c + 1]++;
+        }
+        for (size_t c = 1; c < cellStart.size(); ++c) cellStart[c] += cellStart[c - 1];
+        std::copy(cellStart.begin(), cellStart.end() - 1, cursor.begin());
+        for (size_t i = 0; i < n; ++i) items[cursor[itemCell[i]]++] = (uint32_t) i;
+    }
+
+    // Visit every item stored in the cells overlapping [x0,x1]x[y0,y1].
+    template<class Fn>
+    void query(float x0, float y0, float x1, float y1, Fn fn) const {
+        int c0 = col(x0), c1 = col(x1), r0 = row(y0), r1 = row(y1);
+        for (int r = r0; r <= r1; ++r) {
+            for (int c = c0; c <= c1; ++c) {
+                int k = r * cols + c;
+                for (uint32_t j = cellStart[k]; j < cellStart[k + 1]; ++j) fn(items[j]);
+            }
+        }
+    }
+};
+
+// ----- arena simulation -----
+struct Arena {
+    struct Paddle {
+        uint8_t side;
+        float lo, hi; // travel range of the centre along its edge
+        float pos;    // centre along its edge
+    };
+    struct Ball {
+        float x, y, vx, vy;
+    };
+
+    float W = 800.f, H = 450.f;
+    uint32_t tick = 0;
+    std::vector<Paddle> paddles;
+    std::vector<Ball> balls;
+    bool guarded[4] = {false, false, false, false}; // side has paddles (open goal)
+    UniformGrid grid;
+    uint32_t rng;
+
+    explicit Arena(const ArenaConfig &cfg) : rng(cfg.seed ? cfg.seed : 1) {
+        // Deal paddles round-robin onto the four sides; two players is classic pong.
+        int perSide[4] = {0, 0, 0, 0};
+        for (int i = 0; i < cfg.paddles; ++i) perSide[i % 4]++;
+
+        // Size the world so every paddle gets a segment and ball density stays flat.
+        W = std::max(W, std::max(perSide[SIDE_TOP], perSide[SIDE_BOTTOM]) * ARENA_SEGMENT);
+        H = std::max(H, std::max(perSide[SIDE_LEFT], perSide[SIDE_RIGHT]) * ARENA_SEGMENT);
+        float need = std::sqrt((float) cfg.balls * ARENA_AREA_PER_BALL);
+        if (W * H < need * need) {
+            float k = need / std::sqrt(W * H);
+            W *= k;
+            H *= k;
+        }
+
+        int slot[4] = {0, 0, 0, 0};
+        paddles.reserve(cfg.paddles);
+        for (int i = 0; i < cfg.paddles; ++i) {
+            uint8_t side = (uint8_t) (i % 4);
+            float len = (side == SIDE_LEFT || side == SIDE_RIGHT) ? H : W;
+            float seg = len / (float) perSide[side];
+            float a = seg * (float) slot[side]++;
+            Paddle p{side, a + ARENA_PADDLE_H * 0.5f, a + seg - ARENA_PADDLE_H * 0.5f, a + seg * 0.5f};
+            paddles.push_back(p);
+            guarded[side] = true;
+        }
+
+        balls.resize(cfg.balls);
+        for (Ball &b: balls) spawn(b);
+        grid.resize(W, H, ARENA_CELL);
+    }
+
+    float rand01() {
+        rng = rng * 1664525u + 1013904223u;
+        return (float) (rng >> 8) / 16777216.f;
+    }
+
+    // Random in-field position; respawning everything at the centre would
+    // stack the balls in one grid cell.
+    void spawn(Ball &b) {
+        float ang = rand01() * 6.2831853f;
+        b.x = W * (rand01() * 0.8f + 0.1f);
+        b.y = H * (rand01() * 0.8f + 0.1f);
+        b.vx = std::cos(ang) * ARENA_BALL_SPEED;
+        b.vy = std::sin(ang) * ARENA_BALL_SPEED;
+    }
+
+    // Paddle rectangle (centre + half extents).
+    void paddleRect(const Paddle &p, float &cx, float &cy, float &hw, float &hh) const {
+        switch (p.side) {
+            case SIDE_LEFT:  cx = ARENA_PADDLE_INSET;     cy = p.pos; break;
+            case SIDE_RIGHT: cx = W - ARENA_PADDLE_INSET; cy = p.pos; break;
+            case SIDE_TOP:   cx = p.pos; cy = ARENA_PADDLE_INSET;     break;
+            default:         cx = p.pos; cy = H - ARENA_PADDLE_INSET; break;
+        }
+        bool vertical = (p.side == SIDE_LEFT || p.side == SIDE_RIGHT);
+        hw = (vertical ? ARENA_PADDLE_W : ARENA_PADDLE_H) * 0.5f;
+        hh = (vertical ? ARENA_PADDLE_H : ARENA_PADDLE_W) * 0.5f;
+    }
+
+    // One fixed step; buttons[i] drives paddles[i].
+    void step(const uint8_t *buttons, float dt) {
+        tick++;
+
+        for (size_t i = 0; i < paddles.size(); ++i) {
+            Paddle &p = paddles[i];
+            float dir = 0.f;
+            if (buttons[i] & BTN_UP) dir -= 1.f;
+            if (buttons[i] & BTN_DOWN) dir += 1.f;
+            p.pos = std::min(p.hi, std::max(p.lo, p.pos + dir * ARENA_PADDLE_SPEED * dt));
+        }
+
+        // Integrate; unguarded edges reflect, guarded ones are goals.
+        const float R = ARENA_BALL_R;
+        for (Ball &b: balls) {
+            b.x += b.vx * dt;
+            b.y += b.vy * dt;
+            if (!guarded[SIDE_LEFT] && b.x < R) { b.x = R; b.vx = std::abs(b.vx); }
+            if (!guarded[SIDE_RIGHT] && b.x > W - R) { b.x = W - R; b.vx = -std::abs(b.vx); }
+            if (!guarded[SIDE_TOP] && b.y < R) { b.y = R; b.vy = std::abs(b.vy); }
+            if (!guarded[SIDE_BOTTOM] && b.y > H - R) { b.y = H - R; b.vy = -std::abs(b.vy); }
+            if (b.x < -20.f || b.x > W + 20.f || b.y < -20.f || b.y > H + 20.f) spawn(b);
+        }
+
+        grid.build(balls.size(), [&](size_t i, float &x, float &y) { x = balls[i].x; y = balls[i].y; });
+
+        // Ball-ball: equal-mass elastic bounce, each pair visited once (j > i).
+        for (size_t i = 0; i < balls.size(); ++i) {
+            grid.query(balls[i].x - 2 * R, balls[i].y - 2 * R, balls[i].x + 2 * R, balls[i].y + 2 * R,
+                       [&](uint32_t j) {
+                           if (j <= i) return;
+                           Ball &a = balls[i], &b = balls[j];
+                           float dx = b.x - a.x, dy = b.y - a.y;
+                           float d2 = dx * dx + dy * dy;
+                           if (d2 >= 4 * R * R || d2 <= 1e-6f) return;
+                           float d = std::sqrt(d2), nx = dx / d, ny = dy / d;
+                           float push = (2 * R - d) * 0.5f;
+                           a.x -= nx * push; a.y -= ny * push;
+                           b.x += nx * push; b.y += ny * push;
+                           float vn = (b.vx - a.vx) * nx + (b.vy - a.vy) * ny;
+                           if (vn >= 0.f) return; // already separating
+                           a.vx += vn * nx; a.vy += vn * ny;
+                           b.vx -= vn * nx; b.vy -= vn * ny;
+                       });
+        }
+
+        // Ball-paddle: each paddle only looks at balls in the cells it covers.
+        for (const Paddle &p: paddles) {
+            float cx, cy, hw, hh;
+            paddleRect(p, cx, cy, hw, hh);
+            grid.query(cx - hw - R, cy - hh - R, cx + hw + R, cy + hh + R, [&](uint32_t j) {
+                Ball &b = balls[j];
+                if (b.x + R < cx - hw || b.x - R > cx + hw) return;
+                if (b.y + R < cy - hh || b.y - R > cy + hh) return;
+                switch (p.side) {
+                    case SIDE_LEFT:
+                        b.x = cx + hw + R; b.vx = std::abs(b.vx); b.vy += (b.y - cy) / hh * 60.f; break;
+                    case SIDE_RIGHT:
+                        b.x = cx - hw - R; b.vx = -std::abs(b.vx); b.vy += (b.y - cy) / hh * 60.f; break;
+                    case SIDE_TOP:
+                        b.y = cy + hh + R; b.vy = std::abs(b.vy); b.vx += (b.x - cx) / hw * 60.f; break;
+                    default:
+                        b.y = cy - hh - R; b.vy = -std::abs(b.vy); b.vx += (b.x - cx) / hw * 60.f; break;
+                }
+            });
+        }
+    }
+
+    // Interest management: balls within `radius` of (x, y), via the grid.
+    void ballsNear(float x, float y, float radius, std::vector<uint32_t> &out) const {
+        out.clear();
+        float pad = radius + grid.cell; // grid is from before this tick's collision pushes
+        grid.query(x - pad, y - pad, x + pad, y + pad, [&](uint32_t j) {
+            float dx = balls[j].x - x, dy = balls[j].y - y;
+            if (dx * dx + dy * dy <= radius * radius) out.push_back(j);
+        });
+    }
+
+    // Serialise the view for one client: every paddle, plus up to the balls
+    // listed in `visible` that still fit in one message.
+    void writeState(uint8_t you, const std::vector<uint32_t> &visible, std::vector<char> &buf) const {
+        const size_t fixed = sizeof(SArenaState) + paddles.size() * sizeof(ArenaPaddle);
+        size_t maxBalls = (UINT16_MAX - fixed) / sizeof(ArenaBall);
+        size_t nb = std::min(visible.size(), maxBalls);
+
+        buf.resize(fixed + nb * sizeof(ArenaBall));
+        SArenaState hdr{tick, W, H, you, (uint8_t) paddles.size(), (uint16_t) nb};
+        char *w = buf.data();
+        std::memcpy(w, &hdr, sizeof(hdr));
+        w += sizeof(hdr);
+        for (const Paddle &p: paddles) {
+            ArenaPaddle ap{p.side, p.pos};
+            std::memcpy(w, &ap, sizeof(ap));
+            w += sizeof(ap);
+        }
+        for (size_t k = 0; k < nb; ++k) {
+            const Ball &b = balls[visible[k]];
+            ArenaBall ab{(uint16_t) visible[k], b.x, b.y, b.vx, b.vy};
+            std::memcpy(w, &ab, sizeof(ab));
+            w += sizeof(ab);
+        }
+    }
+};
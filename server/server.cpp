@@ -6,15 +6,19 @@
 #include <vector>
 #include <chrono>
 #include <thread>
+#include <csignal>
+#include <algorithm>
 
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
 using socklen_t = int;
+#define poll WSAPoll
 #else
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -22,6 +26,9 @@ using socklen_t = int;
 #endif
 
 #include "../common/protocol.hpp"
+#include "../common/input.hpp"
+#include "../common/gateway.hpp"
+#include "arena.hpp"
 
 static bool set_tcp_nodelay(int s) {
 #ifdef _WIN32
@@ -32,6 +39,8 @@ static bool set_tcp_nodelay(int s) {
     return setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes)) == 0;
 }
 
+static bool readable(const pollfd &p) { return (p.revents & (POLLIN | POLLHUP | POLLERR)) != 0; }
+
 static uint64_t now_unix_ms() {
     return (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::system_clock::now().time_since_epoch()).count();
@@ -42,33 +51,224 @@ static uint32_t now_steady_ms() {
         std::chrono::steady_clock::now().time_since_epoch()).count();
 }
 
+// Accept one client and run the S_HELLO / C_HELLO handshake. Returns -1 on accept error.
+static int accept_client(int ls, size_t index) {
+    sockaddr_in cli{};
+    socklen_t cl = sizeof(cli);
+    int s = accept(ls, (sockaddr *) &cli, &cl);
+    if (s < 0) {
+        perror("[srv] accept");
+        return -1;
+    }
+    set_tcp_nodelay(s);
+
+    char ip[64];
+    inet_ntop(AF_INET, &cli.sin_addr, ip, sizeof(ip));
+    printf("[srv] client %zu connected: %s:%d (TCP_NODELAY=on)\n",
+           index, ip, ntohs(cli.sin_port));
+
+    // greet
+    send_msg(s, S_HELLO, SHello{now_steady_ms()});
+
+    // optional CHello
+    MsgHeader h{};
+    if (recv_header(s, h) && h.type == C_HELLO && h.size == sizeof(CHello)) {
+        CHello ch{};
+        if (recv_payload(s, ch)) {
+            printf("[srv]   name='%.*s'\n", (int) sizeof(ch.name), ch.name);
+        }
+    } else {
+        printf("[srv]   (no CHello)\n");
+    }
+
+    return s;
+}
+
+// Game constants
+static constexpr float W = 800.f, H = 450.f; // world size
+static constexpr float PADDLE_H = 80.f, PADDLE_W = 10.f;
+static constexpr float BALL_R = 6.f;
+static constexpr float PADDLE_SPEED = 260.f; // px/s
+static constexpr float BALL_SPEED = 260.f;
+static constexpr int broadcastEvery = 3; // every 3 ticks (~20Hz)
+
+// One classic two-player match. The standalone server runs one; a backend runs many.
+struct Match {
+    uint32_t id = 0;
+    int clients[2] = {-1, -1}; // clients[i] drives paddle i; -1 once it has left so slots stay stable
+    InputQueue inputs[2]; // per-client input edges, applied on the tick they were stamped with
+    SState st{};          // authoritative state
+    FrameReader readers[2];
+    size_t pollAt[2] = {0, 0}; // index of each client in the caller's pollfd array
+
+    Match() {
+        st.tick = 0;
+        st.ballX = W * 0.5f;
+        st.ballY = H * 0.5f;
+        st.ballVX = BALL_SPEED;
+        st.ballVY = BALL_SPEED * 0.6f;
+        st.paddleY[0] = H * 0.5f; // center
+        st.paddleY[1] = H * 0.5f;
+    }
+
+    int live() const { return (clients[0] >= 0) + (clients[1] >= 0); }
+
+    void addFds(std::vector<pollfd> &pfds) {
+        for (int i = 0; i < 2; ++i) {
+            if (clients[i] < 0) continue;
+            pollAt[i] = pfds.size();
+            pfds.push_back(pollfd{clients[i], POLLIN, 0});
+        }
+    }
+
+    // Client sockets are non-blocking: reads go through readers[], and a send
+    // that would block drops that client instead of stalling the loop.
+    bool attach(int i, int fd) {
+        clients[i] = fd;
+        return set_nonblocking(fd);
+    }
+
+    void drop(int i) {
+        printf("[srv] client[%d] disconnected\n", i);
+        closesocket(clients[i]);
+        clients[i] = -1;
+        inputs[i] = InputQueue{};
+        readers[i] = FrameReader{};
+    }
+
+    // Take whatever readable clients sent and handle every complete frame;
+    // drops the ones that left.
+    void service(const std::vector<pollfd> &pfds) {
+        for (int i = 0; i < 2; ++i) {
+            int c = clients[i];
+            if (c < 0 || !readable(pfds[pollAt[i]])) continue;
+            if (!readers[i].fill(c)) {
+                drop(i);
+                continue;
+            }
+
+            MsgHeader h{};
+            const char *payload = nullptr;
+            while (clients[i] >= 0 && readers[i].next(h, payload)) {
+                if (h.type == C_PING && h.size == sizeof(CPing)) {
+                    CPing p{};
+                    std::memcpy(&p, payload, sizeof(p));
+                    SPong q{p.clientSendMs, now_unix_ms()};
+                    if (!send_msg(c, S_PONG, q)) drop(i);
+                } else if (h.type == C_INPUT && h.size == sizeof(CInput)) {
+                    CInput ci{};
+                    std::memcpy(&ci, payload, sizeof(ci));
+                    inputs[i].receive(ci, st.tick);
+                }
+                // anything else: skipped, the frame is already consumed
+            }
+        }
+    }
+
+    void step() {
+        st.tick++;
+
+        // Apply inputs to paddles
+        const float dt = SERVER_TICK_MS / 1000.f;
+        for (int p = 0; p < 2; ++p) {
+            if (clients[p] < 0) continue;
+            uint8_t b = inputs[p].advance(st.tick);
+            float dir = 0.f;
+            if (b & BTN_UP) dir -= 1.f;
+            if (b & BTN_DOWN) dir += 1.f;
+            st.paddleY[p] += dir * PADDLE_SPEED * dt;
+            if (st.paddleY[p] < PADDLE_H * 0.5f) st.paddleY[p] = PADDLE_H * 0.5f;
+            if (st.paddleY[p] > H - PADDLE_H * 0.5f) st.paddleY[p] = H - PADDLE_H * 0.5f;
+        }
+
+        // Move ball + simple collisions
+        st.ballX += st.ballVX * dt;
+        st.ballY += st.ballVY * dt;
+
+        if (st.ballY < BALL_R) {
+            st.ballY = BALL_R;
+            st.ballVY = -st.ballVY;
+        }
+        if (st.ballY > H - BALL_R) {
+            st.ballY = H - BALL_R;
+            st.ballVY = -st.ballVY;
+        }
+
+        auto collidePaddle = [&](float px, float pyCenter, int side) {
+            const float halfH = PADDLE_H * 0.5f;
+            float left = px - PADDLE_W * 0.5f, right = px + PADDLE_W * 0.5f;
+            float top = pyCenter - halfH, bot = pyCenter + halfH;
+            if (st.ballX + BALL_R < left || st.ballX - BALL_R > right) return false;
+            if (st.ballY + BALL_R < top || st.ballY - BALL_R > bot) return false;
+            st.ballX = (side == 0) ? right + BALL_R : left - BALL_R;
+            st.ballVX = (side == 0) ? std::abs(st.ballVX) : -std::abs(st.ballVX);
+            float t = (st.ballY - pyCenter) / halfH;
+            st.ballVY += t * 60.f;
+            return true;
+        };
+        collidePaddle(20.f, st.paddleY[0], 0);
+        collidePaddle(W - 20.f, st.paddleY[1], 1);
+
+        if (st.ballX < -20.f || st.ballX > W + 20.f) {
+            st.ballX = W * 0.5f;
+            st.ballY = H * 0.5f;
+            st.ballVX = (st.ballVX < 0 ? 1.f : -1.f) * BALL_SPEED;
+            st.ballVY = BALL_SPEED * 0.6f;
+        }
+    }
+
+    void broadcast() {
+        for (int i = 0; i < 2; ++i) {
+            if (clients[i] >= 0 && !send_msg(clients[i], S_STATE, st)) drop(i);
+        }
+    }
+};
+
+// poll() timeout in ms: poll inputs often (<= 2 ms) without overshooting the next tick.
+static int poll_timeout(std::chrono::steady_clock::time_point nextTick) {
+    auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(
+        nextTick - std::chrono::steady_clock::now()).count();
+    if (remain > 2) remain = 2;
+    if (remain < 0) remain = 0;
+    return (int) remain;
+}
+
+static int run_arena(int ls, int players, int balls);
+#ifndef _WIN32
+static int run_backend(const char *path);
+#endif
+
 int main(int argc, char **argv) {
 #ifdef _WIN32
     WSADATA wsa; WSAStartup(MAKEWORD(2, 2), &wsa);
 #endif
 
-    // Game constants
-    const float W = 800.f, H = 450.f; // world size
-    const float PADDLE_H = 80.f, PADDLE_W = 10.f;
-    const float BALL_R = 6.f;
-    const float PADDLE_SPEED = 260.f; // px/s
-    const float BALL_SPEED = 260.f;
-
-    // Authoritative state
-    SState st{};
-    st.tick = 0;
-    st.ballX = W * 0.5f;
-    st.ballY = H * 0.5f;
-    st.ballVX = BALL_SPEED;
-    st.ballVY = BALL_SPEED * 0.6f;
-    st.paddleY[0] = H * 0.5f; // center
-    st.paddleY[1] = H * 0.5f;
-
-    // Per-client input latch (0 or BTN_UP/DOWN or both)
-    uint8_t inputs[2] = {0, 0};
-
     int port = 7777;
-    if (argc >= 3 && std::string(argv[1]) == "--port") port = std::atoi(argv[2]);
+    int arenaPlayers = 0, arenaBalls = 64; // --arena N switches to the N-player arena
+    const char *backendPath = nullptr;     // --backend PATH serves matches handed over by pong_gateway
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string k = argv[i];
+        if (k == "--port") port = std::atoi(argv[i + 1]);
+        else if (k == "--arena") arenaPlayers = std::atoi(argv[i + 1]);
+        else if (k == "--balls") arenaBalls = std::atoi(argv[i + 1]);
+        else if (k == "--backend") backendPath = argv[i + 1];
+    }
+    if (arenaPlayers < 0) {
+        printf("[srv] --arena needs a player count >= 1\n");
+        return 1;
+    }
+    if (arenaPlayers > 255) arenaPlayers = 255;
+    if (arenaBalls < 0) arenaBalls = 0;
+    if (arenaBalls > UINT16_MAX) arenaBalls = UINT16_MAX;
+
+    if (backendPath) {
+#ifndef _WIN32
+        return run_backend(backendPath);
+#else
+        printf("[srv] --backend needs Unix domain sockets\n");
+        return 1;
+#endif
+    }
 
     // listening socket
     int ls = socket(AF_INET, SOCK_STREAM, 0);
@@ -89,195 +289,306 @@ int main(int argc, char **argv) {
         perror("[srv] bind");
         return 1;
     }
-    if (listen(ls, 2) < 0) {
+    if (listen(ls, arenaPlayers > 2 ? arenaPlayers : 2) < 0) {
         perror("[srv] listen");
         return 1;
     }
 
     printf("[srv] listening on 0.0.0.0:%d\n", port);
+    if (arenaPlayers > 0) return run_arena(ls, arenaPlayers, arenaBalls);
 
     // accept exactly two clients
-    std::vector<int> clients;
-    clients.reserve(2);
-    while ((int) clients.size() < 2) {
-        sockaddr_in cli{};
-        socklen_t cl = sizeof(cli);
-        int s = accept(ls, (sockaddr *) &cli, &cl);
-        if (s < 0) {
-            perror("[srv] accept");
-            return 1;
-        }
-        set_tcp_nodelay(s);
-
-        char ip[64];
-        inet_ntop(AF_INET, &cli.sin_addr, ip, sizeof(ip));
-        printf("[srv] client %zu connected: %s:%d (TCP_NODELAY=on)\n",
-               clients.size(), ip, ntohs(cli.sin_port));
-
-        // greet
-        send_msg(s, S_HELLO, SHello{now_steady_ms()});
-
-        // optional CHello
-        MsgHeader h{};
-        if (recv_header(s, h) && h.type == C_HELLO && h.size == sizeof(CHello)) {
-            CHello ch{};
-            if (recv_payload(s, ch)) {
-                printf("[srv]   name='%.*s'\n", (int) sizeof(ch.name), ch.name);
-            }
-        } else {
-            printf("[srv]   (no CHello)\n");
-        }
-
-        clients.push_back(s);
+    Match m;
+    for (int i = 0; i < 2; ++i) {
+        int s = accept_client(ls, i);
+        if (s < 0) return 1;
+        m.attach(i, s);
     }
 
     printf("[srv] two clients connected, starting 1 Hz broadcast + ping handler\n");
 
     auto nextTick = std::chrono::steady_clock::now();
-    const auto dt = std::chrono::milliseconds(16); // ~60Hz
-    auto nextBroadcast = nextTick; // broadcast at 20Hz
-    constexpr int broadcastEvery = 3; // every 3 ticks (~20Hz)
+    const auto dt = std::chrono::milliseconds(SERVER_TICK_MS); // ~60Hz
 
     for (;;) {
         // ---- 1) Poll inputs often (≤ 2 ms) ----
-        fd_set rfds;
-        FD_ZERO(&rfds);
-        int maxfd = -1;
-        for (int c: clients) {
-            FD_SET(c, &rfds);
-            if (c > maxfd) maxfd = c;
+        std::vector<pollfd> pfds;
+        m.addFds(pfds);
+
+        int ready = poll(pfds.data(), (unsigned long) pfds.size(), poll_timeout(nextTick));
+        if (ready > 0) m.service(pfds);
+
+        // ---- 2) Fixed tick ----
+        auto now = std::chrono::steady_clock::now();
+        if (now < nextTick) continue;
+        nextTick += dt;
+        m.step();
+
+        // ---- 3) Broadcast ~20 Hz ----
+        if ((m.st.tick % broadcastEvery) == 0) m.broadcast();
+    }
+
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 0;
+}
+
+// N-player arena: paddles on all four edges, many balls, grid broadphase, and
+// per-client state trimmed to the balls near that client's paddle.
+static int run_arena(int ls, int players, int balls) {
+    ArenaConfig cfg;
+    cfg.paddles = players;
+    cfg.balls = balls;
+    Arena arena(cfg);
+    printf("[srv] arena: %d paddles, %d balls, world %.0fx%.0f\n", players, balls, arena.W, arena.H);
+
+    // clients[i] drives paddles[i]; -1 once it has left so indices stay stable
+    std::vector<int> clients;
+    clients.reserve(players);
+    while ((int) clients.size() < players) {
+        int s = accept_client(ls, clients.size());
+        if (s < 0) return 1;
+        // same policy as Match: framed non-blocking reads, a send that would block drops
+        if (!set_nonblocking(s)) {
+            perror("[srv] set_nonblocking");
+            return 1;
         }
+        clients.push_back(s);
+    }
+
+    printf("[srv] %d clients connected, starting arena\n", players);
 
-        auto now_for_poll = std::chrono::steady_clock::now();
-        auto remain = nextTick - now_for_poll;
+    std::vector<InputQueue> inputs(players);
+    std::vector<FrameReader> readers(players);
+    std::vector<uint8_t> buttons(players, 0);
+    std::vector<uint32_t> visible;
+    std::vector<char> out;
+    std::vector<pollfd> pfds;
+    std::vector<size_t> pollAt(players, 0);
 
-        if (remain > std::chrono::milliseconds(2)) remain = std::chrono::milliseconds(2);
-        if (remain < std::chrono::milliseconds(0)) remain = std::chrono::milliseconds(0);
+    auto drop = [&](size_t i) {
+        printf("[srv] client[%zu] disconnected\n", i);
+        closesocket(clients[i]);
+        clients[i] = -1;
+        inputs[i] = InputQueue{}; // or the paddle keeps the last buttons held
+        readers[i] = FrameReader{};
+    };
 
-        long usec = std::chrono::duration_cast<std::chrono::microseconds>(remain).count();
-        timeval tv{(int) (usec / 1000000), (int) (usec % 1000000)};
+    auto nextTick = std::chrono::steady_clock::now();
+    const auto dt = std::chrono::milliseconds(SERVER_TICK_MS);
 
-        int ready = select(maxfd + 1, &rfds, nullptr, nullptr, &tv);
+    for (;;) {
+        // ---- 1) Poll inputs often (<= 2 ms) ----
+        pfds.clear();
+        for (size_t i = 0; i < clients.size(); ++i) {
+            if (clients[i] < 0) continue;
+            pollAt[i] = pfds.size();
+            pfds.push_back(pollfd{clients[i], POLLIN, 0});
+        }
+
+        int ready = poll(pfds.data(), (unsigned long) pfds.size(), poll_timeout(nextTick));
         if (ready > 0) {
-            for (size_t i = 0; i < clients.size();) {
+            for (size_t i = 0; i < clients.size(); ++i) {
                 int c = clients[i];
-                if (!FD_ISSET(c, &rfds)) {
-                    ++i;
-                    continue;
-                }
+                if (c < 0 || !readable(pfds[pollAt[i]])) continue;
 
-                MsgHeader h{};
-                if (!recv_header(c, h)) {
-                    printf("[srv] client[%zu] disconnected\n", i);
-                    closesocket(c);
-                    clients.erase(clients.begin() + (long) i);
+                if (!readers[i].fill(c)) {
+                    drop(i);
                     continue;
                 }
 
-                if (h.type == C_PING && h.size == sizeof(CPing)) {
-                    CPing p{};
-                    if (recv_payload(c, p)) {
-                        SPong q{p.clientSendMs, now_unix_ms()};
-                        send_msg(c, S_PONG, q);
-                    } else {
-                        closesocket(c);
-                        clients.erase(clients.begin() + (long) i);
-                        continue;
-                    }
-                } else if (h.type == C_INPUT && h.size == sizeof(CInput)) {
-                    CInput ci{};
-                    if (!recv_payload(c, ci)) {
-                        closesocket(c);
-                        clients.erase(clients.begin() + (long) i);
-                        continue;
-                    }
-                    size_t playerIndex = i;
-                    if (playerIndex > 1) playerIndex = 1;
-                    inputs[playerIndex] = ci.buttons;
-                } else {
-                    std::vector<char> junk(h.size);
-                    if (!recv_all(c, junk.data(), (int) junk.size())) {
-                        closesocket(c);
-                        clients.erase(clients.begin() + (long) i);
-                        continue;
+                MsgHeader h{};
+                const char *payload = nullptr;
+                while (clients[i] >= 0 && readers[i].next(h, payload)) {
+                    if (h.type == C_PING && h.size == sizeof(CPing)) {
+                        CPing p{};
+                        std::memcpy(&p, payload, sizeof(p));
+                        if (!send_msg(c, S_PONG, SPong{p.clientSendMs, now_unix_ms()})) drop(i);
+                    } else if (h.type == C_INPUT && h.size == sizeof(CInput)) {
+                        CInput ci{};
+                        std::memcpy(&ci, payload, sizeof(ci));
+                        inputs[i].receive(ci, arena.tick);
                     }
+                    // anything else: skipped, the frame is already consumed
                 }
-                ++i;
             }
         }
 
         // ---- 2) Fixed tick ----
-        auto now = std::chrono::steady_clock::now();
-        if (now < nextTick) continue;
+        if (std::chrono::steady_clock::now() < nextTick) continue;
         nextTick += dt;
-        st.tick++;
 
-        // Apply inputs to paddles
-        const float PADDLE_SPEED = 260.f, H = 450.f, PADDLE_H = 80.f;
-        for (int p = 0; p < 2 && p < (int) clients.size(); ++p) {
-            float dir = 0.f;
-            if (inputs[p] & BTN_UP) dir -= 1.f;
-            if (inputs[p] & BTN_DOWN) dir += 1.f;
-            st.paddleY[p] += dir * PADDLE_SPEED * (16.0f / 1000.f);
-            if (st.paddleY[p] < PADDLE_H * 0.5f) st.paddleY[p] = PADDLE_H * 0.5f;
-            if (st.paddleY[p] > H - PADDLE_H * 0.5f) st.paddleY[p] = H - PADDLE_H * 0.5f;
+        for (int p = 0; p < players; ++p) buttons[p] = inputs[p].advance(arena.tick + 1);
+        arena.step(buttons.data(), SERVER_TICK_MS / 1000.f);
+
+        // ---- 3) Broadcast ~20 Hz, each client sees only balls near its paddle ----
+        if ((arena.tick % broadcastEvery) == 0) {
+            for (size_t i = 0; i < clients.size(); ++i) {
+                if (clients[i] < 0) continue;
+                float cx, cy, hw, hh;
+                arena.paddleRect(arena.paddles[i], cx, cy, hw, hh);
+                arena.ballsNear(cx, cy, ARENA_VIEW_R, visible);
+                arena.writeState((uint8_t) i, visible, out);
+                if (!send_bytes(clients[i], S_ARENA_STATE, out.data(), (uint16_t) out.size())) drop(i);
+            }
         }
+    }
+}
 
-        // Move ball + simple collisions
-        const float W = 800.f, BALL_R = 6.f;
-        st.ballX += st.ballVX * (16.0f / 1000.f);
-        st.ballY += st.ballVY * (16.0f / 1000.f);
+#ifndef _WIN32
+static volatile std::sig_atomic_t g_draining = 0;
+
+// Backend for pong_gateway: accepts gateway control connections on a Unix
+// socket, receives both client fds of each match already past the handshake,
+// and runs every match on one shared tick. SIGTERM drains: the next load
+// report says draining=1, assignments already on their way are still run, and
+// the process exits once no match is left and no G_ASSIGN has arrived for a
+// report period after the gateway was told.
+static int run_backend(const char *path) {
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGTERM, [](int) { g_draining = 1; });
+
+    sockaddr_un ua{};
+    if (!unix_addr(path, ua)) {
+        printf("[srv] backend path too long: %s\n", path);
+        return 1;
+    }
+    int ls = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (ls < 0) {
+        perror("[srv] socket");
+        return 1;
+    }
+    unlink(path);
+    if (bind(ls, (sockaddr *) &ua, sizeof(ua)) < 0) {
+        perror("[srv] bind");
+        return 1;
+    }
+    if (listen(ls, 4) < 0) {
+        perror("[srv] listen");
+        return 1;
+    }
+    printf("[srv] backend listening on %s\n", path);
 
-        if (st.ballY < BALL_R) {
-            st.ballY = BALL_R;
-            st.ballVY = -st.ballVY;
-        }
-        if (st.ballY > H - BALL_R) {
-            st.ballY = H - BALL_R;
-            st.ballVY = -st.ballVY;
-        }
+    std::vector<int> gateways;
+    std::vector<Match> matches;
+    std::vector<pollfd> pfds;
 
-        auto collidePaddle = [&](float px, float pyCenter, int side) {
-            const float PADDLE_W = 10.f;
-            const float halfH = PADDLE_H * 0.5f;
-            float left = px - PADDLE_W * 0.5f, right = px + PADDLE_W * 0.5f;
-            float top = pyCenter - halfH, bot = pyCenter + halfH;
-            if (st.ballX + BALL_R < left || st.ballX - BALL_R > right) return false;
-            if (st.ballY + BALL_R < top || st.ballY - BALL_R > bot) return false;
-            st.ballX = (side == 0) ? right + BALL_R : left - BALL_R;
-            st.ballVX = (side == 0) ? std::abs(st.ballVX) : -std::abs(st.ballVX);
-            float t = (st.ballY - pyCenter) / halfH;
-            st.ballVY += t * 60.f;
-            return true;
-        };
-        collidePaddle(20.f, st.paddleY[0], 0);
-        collidePaddle(W - 20.f, st.paddleY[1], 1);
+    auto nextTick = std::chrono::steady_clock::now();
+    auto nextReport = nextTick;
+    const auto dt = std::chrono::milliseconds(SERVER_TICK_MS);
+    uint64_t tickNs = 0;
+    uint32_t ticks = 0;
+    bool drainReported = false;       // a draining=1 report went out
+    auto drainQuietFrom = nextTick;   // later of that report and the last G_ASSIGN
 
-        if (st.ballX < -20.f || st.ballX > W + 20.f) {
-            const float BALL_SPEED = 260.f;
-            st.ballX = W * 0.5f;
-            st.ballY = H * 0.5f;
-            st.ballVX = (st.ballVX < 0 ? 1.f : -1.f) * BALL_SPEED;
-            st.ballVY = BALL_SPEED * 0.6f;
+    for (;;) {
+        // poll, not select: hundreds of matches put fds past FD_SETSIZE
+        pfds.clear();
+        pfds.push_back(pollfd{ls, POLLIN, 0});
+        for (int g: gateways) pfds.push_back(pollfd{g, POLLIN, 0});
+        size_t polledGateways = gateways.size(); // they sit at pfds[1..]
+        for (Match &m: matches) m.addFds(pfds);
+
+        int ready = poll(pfds.data(), (unsigned long) pfds.size(), poll_timeout(nextTick));
+        if (ready > 0) {
+            if (readable(pfds[0])) {
+                int g = accept(ls, nullptr, nullptr);
+                if (g >= 0) {
+                    printf("[srv] gateway connected\n");
+                    gateways.push_back(g);
+                }
+            }
+
+            // existing matches first: ones added below are not in pfds yet
+            for (Match &m: matches) m.service(pfds);
+
+            // gateways accepted above are polled from the next round on
+            for (size_t i = 0; i < polledGateways; ++i) {
+                int g = gateways[i];
+                if (g < 0 || !readable(pfds[1 + i])) continue;
+                MsgHeader h{};
+                int fds[MATCH_PLAYERS];
+                int nfds = 0;
+                GAssign ga{};
+                bool ok = recv_header_fds(g, h, fds, nfds);
+                if (ok && h.type == G_ASSIGN && h.size == sizeof(GAssign) && recv_payload(g, ga)) {
+                    Match m;
+                    m.id = ga.matchId;
+                    for (int k = 0; k < nfds; ++k) m.attach(k, fds[k]);
+                    printf("[srv] match %u assigned (%d players)\n", m.id, nfds);
+                    matches.push_back(std::move(m));
+                    drainQuietFrom = std::chrono::steady_clock::now();
+                } else {
+                    for (int k = 0; k < nfds; ++k) closesocket(fds[k]);
+                    std::vector<char> junk(ok ? h.size : 0);
+                    if (!ok || !recv_all(g, junk.data(), (int) junk.size())) {
+                        printf("[srv] gateway disconnected\n");
+                        closesocket(g);
+                        gateways[i] = -1;
+                    }
+                }
+            }
+            gateways.erase(std::remove(gateways.begin(), gateways.end(), -1), gateways.end());
         }
 
-        // ---- 3) Broadcast ~20 Hz ----
-        if ((st.tick % broadcastEvery) == 0) {
-            for (size_t i = 0; i < clients.size();) {
-                int c = clients[i];
-                if (!send_msg(c, S_STATE, st)) {
-                    closesocket(c);
-                    clients.erase(clients.begin() + (long) i);
+        // ---- Fixed tick: every match steps together ----
+        auto now = std::chrono::steady_clock::now();
+        if (now >= nextTick) {
+            nextTick += dt;
+            for (Match &m: matches) {
+                m.step();
+                if ((m.st.tick % broadcastEvery) == 0) m.broadcast();
+            }
+            for (size_t i = 0; i < matches.size();) {
+                if (matches[i].live() > 0) {
+                    ++i;
                     continue;
                 }
-                ++i;
+                printf("[srv] match %u over\n", matches[i].id);
+                matches.erase(matches.begin() + (long) i);
             }
+            tickNs += (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - now).count();
+            ticks++;
         }
-    }
 
+        // ---- Health/load report (straight away once draining starts) ----
+        if (now >= nextReport || (g_draining && !drainReported)) {
+            nextReport = now + std::chrono::milliseconds(LOAD_REPORT_MS);
+            GLoad ld{};
+            ld.matches = (uint16_t) matches.size();
+            for (const Match &m: matches) ld.clients = (uint16_t) (ld.clients + m.live());
+            ld.tickUs = ticks ? (uint32_t) (tickNs / ticks / 1000) : 0;
+            ld.draining = g_draining ? 1 : 0;
+            if (ld.draining && !drainReported) {
+                printf("[srv] draining\n");
+                drainReported = true;
+                drainQuietFrom = now;
+            }
+            tickNs = 0;
+            ticks = 0;
+            for (size_t i = 0; i < gateways.size();) {
+                if (send_msg(gateways[i], G_LOAD, ld, MSG_DONTWAIT)) {
+                    ++i;
+                    continue;
+                }
+                printf("[srv] gateway not keeping up, disconnecting\n");
+                closesocket(gateways[i]);
+                gateways.erase(gateways.begin() + (long) i);
+            }
+        }
 
-#ifdef _WIN32
-    WSACleanup();
-#endif
-    return 0;
+        if (drainReported && matches.empty() &&
+            now - drainQuietFrom >= std::chrono::milliseconds(LOAD_REPORT_MS)) {
+            printf("[srv] drained, exiting\n");
+            // listener first, so the gateway can't reconnect in between
+            closesocket(ls);
+            unlink(path);
+            for (int g: gateways) closesocket(g);
+            return 0;
+        }
+    }
 }
+#endif